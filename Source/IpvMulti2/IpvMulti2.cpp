@@ -3,5 +3,6 @@
 #include "IpvMulti2.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogIpvMulti2Server);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, IpvMulti2, "IpvMulti2" );
- 
\ No newline at end of file
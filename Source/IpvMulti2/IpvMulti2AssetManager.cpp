@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IpvMulti2AssetManager.h"
+#include "Misc/Paths.h"
+#include "UObject/Package.h"
+
+#if WITH_EDITOR
+#include "Interfaces/ITargetPlatform.h"
+#endif
+
+#if WITH_EDITOR
+bool UIpvMulti2AssetManager::ShouldCookForPlatform(const UPackage* Package, const ITargetPlatform* TargetPlatform)
+{
+	if (Package && TargetPlatform && TargetPlatform->IsServerOnly())
+	{
+		const FString PackageName = Package->GetName();
+		for (const FString& Directory : ServerNeverCookDirectories)
+		{
+			if (FPaths::IsUnderDirectory(PackageName, Directory))
+			{
+				return false;
+			}
+		}
+	}
+	return Super::ShouldCookForPlatform(Package, TargetPlatform);
+}
+#endif
@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetManager.h"
+#include "IpvMulti2AssetManager.generated.h"
+
+/**
+ * Project asset manager. Keeps unreferenced content out of dedicated server cooks. This shrinks
+ * the server build on disk; it does not change server memory, since nothing loads that content.
+ */
+UCLASS(config=Game)
+class UIpvMulti2AssetManager : public UAssetManager
+{
+	GENERATED_BODY()
+
+public:
+#if WITH_EDITOR
+	virtual bool ShouldCookForPlatform(const UPackage* Package, const ITargetPlatform* TargetPlatform) override;
+#endif
+
+protected:
+	/** Long package paths (e.g. /Game/StarterContent) that are never cooked for server-only platforms. */
+	UPROPERTY(Config)
+	TArray<FString> ServerNeverCookDirectories;
+};
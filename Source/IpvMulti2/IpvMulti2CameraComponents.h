@@ -0,0 +1,28 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Camera/CameraComponent.h"
+#include "GameFramework/SpringArmComponent.h"
+#include "IpvMulti2CameraComponents.generated.h"
+
+/** Spring arm that is only cooked and loaded for clients. */
+UCLASS(ClassGroup=Camera)
+class UIpvMulti2SpringArmComponent : public USpringArmComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool NeedsLoadForServer() const override { return false; }
+};
+
+/** Camera that is only cooked and loaded for clients. */
+UCLASS(ClassGroup=Camera)
+class UIpvMulti2CameraComponent : public UCameraComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool NeedsLoadForServer() const override { return false; }
+};
@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "IpvMulti2Character.h"
+#include "IpvMulti2CameraComponents.h"
 #include "Engine/LocalPlayer.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -49,16 +50,27 @@ FindSessionsCompleteDelegate(FOnFindSessionsCompleteDelegate::CreateUObject(this
 	GetCharacterMovement()->BrakingDecelerationWalking = 2000.f;
 	GetCharacterMovement()->BrakingDecelerationFalling = 1500.0f;
 
-	// Create a camera boom (pulls in towards the player if there is a collision)
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
-	CameraBoom->SetupAttachment(RootComponent);
-	CameraBoom->TargetArmLength = 400.0f; // The camera follows at this distance behind the character	
-	CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
+	// Nobody looks through the camera on a dedicated server, so don't pay for it on every pawn.
+	// Both are optional client-only subobjects: server cooks drop their Blueprint overrides as well.
+	if (!IsRunningDedicatedServer())
+	{
+		// Create a camera boom (pulls in towards the player if there is a collision)
+		CameraBoom = CreateOptionalDefaultSubobject<UIpvMulti2SpringArmComponent>(TEXT("CameraBoom"));
+		if (CameraBoom)
+		{
+			CameraBoom->SetupAttachment(RootComponent);
+			CameraBoom->TargetArmLength = 400.0f; // The camera follows at this distance behind the character	
+			CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
+		}
 
-	// Create a follow camera
-	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
-	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
-	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
+		// Create a follow camera
+		FollowCamera = CreateOptionalDefaultSubobject<UIpvMulti2CameraComponent>(TEXT("FollowCamera"));
+		if (FollowCamera && CameraBoom)
+		{
+			FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
+			FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
+		}
+	}
 
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
@@ -123,6 +135,9 @@ void AIpvMulti2Character::SetupPlayerInputComponent(UInputComponent* PlayerInput
 
 		// Looking
 		EnhancedInputComponent->BindAction(LookAction, ETriggerEvent::Triggered, this, &AIpvMulti2Character::Look);
+
+		// Firing
+		EnhancedInputComponent->BindAction(FireAction, ETriggerEvent::Started, this, &AIpvMulti2Character::RequestFire);
 	}
 	else
 	{
@@ -166,6 +181,15 @@ void AIpvMulti2Character::AddAmmo(int32 Amount)
     }
 }
 
+void AIpvMulti2Character::ConsumeAmmo(int32 Amount)
+{
+    if (GetLocalRole() == ROLE_Authority)
+    {
+        CurrentAmmo = FMath::Clamp(CurrentAmmo - Amount, 0, MaxAmmo);
+        OnAmmoUpdated();
+    }
+}
+
 void AIpvMulti2Character::OnHealthUpdate_Implementation()
 {
     bReplicates = true;
@@ -425,6 +449,24 @@ void AIpvMulti2Character::JoinGameSession()
     OnlineSessionInterface->FindSessions(*LocalPlayer->GetPreferredUniqueNetId(),SessionSearch.ToSharedRef());
 }
 
+void AIpvMulti2Character::RequestFire()
+{
+    ServerFire();
+}
+
+void AIpvMulti2Character::ServerFire_Implementation()
+{
+    // Dead or empty characters can't fire
+    if (bIsRagdoll || CurrentAmmo <= 0) return;
+
+    ConsumeAmmo(1);
+}
+
+void AIpvMulti2Character::RequestRespawn()
+{
+    ServerRespawn();
+}
+
 void AIpvMulti2Character::ServerRespawn_Implementation()
 {
     // Reset health
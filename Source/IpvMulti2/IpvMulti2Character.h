@@ -22,13 +22,13 @@ class AIpvMulti2Character : public ACharacter
 {
 	GENERATED_BODY()
 
-	/** Camera boom positioning the camera behind the character */
+	/** Camera boom positioning the camera behind the character. Not created on dedicated servers. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-	USpringArmComponent* CameraBoom;
+	USpringArmComponent* CameraBoom = nullptr;
 
-	/** Follow camera */
+	/** Follow camera. Not created on dedicated servers. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
-	UCameraComponent* FollowCamera;
+	UCameraComponent* FollowCamera = nullptr;
 	
 	/** MappingContext */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
@@ -46,6 +46,7 @@ class AIpvMulti2Character : public ACharacter
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
 	UInputAction* LookAction;
 
+	/** Fire Input Action. The template ships no asset for it; assign one in the character Blueprint.*/
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input, meta = (AllowPrivateAccess = "true"))
 	UInputAction* FireAction;
 
@@ -85,6 +86,7 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Health")
     float TakeDamage( float DamageTaken, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser ) override;
     
+    /** Camera getters. Both return null on dedicated servers.*/
     FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
     FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
 
@@ -100,6 +102,22 @@ public:
     UFUNCTION(BlueprintCallable, Category="Ammo")
     void AddAmmo(int32 Amount);
 
+    /** Function to spend ammo (used by ServerFire). Should only be called on the server.*/
+    UFUNCTION(BlueprintCallable, Category="Ammo")
+    void ConsumeAmmo(int32 Amount);
+
+    /** Asks the server to fire one shot. Bound to FireAction; call on the owning client.*/
+    UFUNCTION(BlueprintCallable, Category="Ammo")
+    void RequestFire();
+
+    /** Asks the server to respawn this character. Call on the owning client.*/
+    UFUNCTION(BlueprintCallable, Category="Respawn")
+    void RequestRespawn();
+
+    /** Getter for the replicated ragdoll state.*/
+    UFUNCTION(BlueprintPure, Category="Health")
+    FORCEINLINE bool IsRagdoll() const { return bIsRagdoll; }
+
     UPROPERTY(BlueprintReadOnly, Category="Gameplay")
     bool bIsCarryingObjective;
 
@@ -151,6 +169,9 @@ protected:
     UFUNCTION(Server, Reliable)
     void ServerRespawn();
 
+    UFUNCTION(Server, Reliable)
+    void ServerFire();
+
     void UpdateTimerDisplay();
     
     UPROPERTY(BlueprintReadOnly, Category = "UI")
@@ -172,6 +193,7 @@ protected:
     //Callbacks
     void OnCreateSessionComplete(FName SessionName, bool bWasSuccess);
 
+    /** Searches presence (listen server) sessions. Pooled dedicated matches are not listed; connect to the address from the allocator's /match instead.*/
     UFUNCTION(BlueprintCallable)
     void JoinGameSession();
 
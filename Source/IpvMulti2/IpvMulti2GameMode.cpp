@@ -1,8 +1,14 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "IpvMulti2GameMode.h"
+#include "IpvMulti2.h"
 #include "IpvMulti2Character.h"
+#include "IpvMulti2MatchSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "HAL/PlatformMemory.h"
+#include "TimerManager.h"
 #include "UObject/ConstructorHelpers.h"
+#include "UObject/UObjectArray.h"
 
 AIpvMulti2GameMode::AIpvMulti2GameMode()
 {
@@ -13,3 +19,118 @@ AIpvMulti2GameMode::AIpvMulti2GameMode()
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
 }
+
+void AIpvMulti2GameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	// A pooled dedicated server starts play while warming up, long before it is allocated a match
+	if (UIpvMulti2MatchSubsystem* MatchSubsystem = GetMatchSubsystem())
+	{
+		MatchSubsystem->OnMatchStarted.AddUObject(this, &ThisClass::OnMatchStarted);
+		MatchSubsystem->OnMatchEnded.AddUObject(this, &ThisClass::OnMatchEnded);
+		return;
+	}
+
+	MatchStartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	OnMatchStarted();
+}
+
+void AIpvMulti2GameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UIpvMulti2MatchSubsystem* MatchSubsystem = GetMatchSubsystem())
+	{
+		MatchSubsystem->OnMatchStarted.RemoveAll(this);
+		MatchSubsystem->OnMatchEnded.RemoveAll(this);
+	}
+	else
+	{
+		OnMatchEnded();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AIpvMulti2GameMode::OnMatchStarted()
+{
+	PeakNumPlayers = GetNumPlayers();
+	PeakMatchUsedPhysical = 0;
+	SampleMatchMemory();
+	GetWorldTimerManager().SetTimer(MemorySampleTimerHandle, this, &ThisClass::SampleMatchMemory, MemorySampleInterval, true);
+
+	LogMemorySummary(TEXT("MatchStart"), false);
+}
+
+void AIpvMulti2GameMode::OnMatchEnded()
+{
+	GetWorldTimerManager().ClearTimer(MemorySampleTimerHandle);
+	SampleMatchMemory();
+
+	LogMemorySummary(TEXT("MatchEnd"), true);
+}
+
+UIpvMulti2MatchSubsystem* AIpvMulti2GameMode::GetMatchSubsystem() const
+{
+	UGameInstance* GameInstance = GetGameInstance();
+	return GameInstance ? GameInstance->GetSubsystem<UIpvMulti2MatchSubsystem>() : nullptr;
+}
+
+void AIpvMulti2GameMode::PostLogin(APlayerController* NewPlayer)
+{
+	Super::PostLogin(NewPlayer);
+
+	PeakNumPlayers = FMath::Max(PeakNumPlayers, GetNumPlayers());
+	SampleMatchMemory();
+}
+
+void AIpvMulti2GameMode::Logout(AController* Exiting)
+{
+	// Sample while the player is still there, the match is released below once the last one leaves
+	SampleMatchMemory();
+
+	Super::Logout(Exiting);
+
+	// The exiting controller is still counted while Logout runs
+	const int32 RemainingPlayers = GetNumPlayers() - (Cast<APlayerController>(Exiting) ? 1 : 0);
+	if (RemainingPlayers > 0) return;
+
+	if (UIpvMulti2MatchSubsystem* MatchSubsystem = GetMatchSubsystem())
+	{
+		MatchSubsystem->ReleaseMatch();
+	}
+}
+
+void AIpvMulti2GameMode::SampleMatchMemory()
+{
+	// Pooled servers measure from the warm, idle server; otherwise from when play started
+	const UIpvMulti2MatchSubsystem* MatchSubsystem = GetMatchSubsystem();
+	const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	const uint64 MatchUsedPhysical = MatchSubsystem ? MatchSubsystem->GetMatchUsedPhysical()
+		: UsedPhysical > MatchStartUsedPhysical ? UsedPhysical - MatchStartUsedPhysical : 0;
+
+	PeakMatchUsedPhysical = FMath::Max(PeakMatchUsedPhysical, MatchUsedPhysical);
+}
+
+void AIpvMulti2GameMode::LogMemorySummary(const TCHAR* Phase, bool bIncludeMatchPeak) const
+{
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+
+	// Bytes per match is the peak over the whole match, so it only means something once the match is over
+	FString MatchPeak;
+	if (bIncludeMatchPeak)
+	{
+		MatchPeak = FString::Printf(TEXT(" Players=%d BytesPerMatch=%llu BytesPerPlayer=%llu"),
+			PeakNumPlayers,
+			PeakMatchUsedPhysical,
+			PeakNumPlayers > 0 ? PeakMatchUsedPhysical / PeakNumPlayers : 0);
+	}
+
+	UE_LOG(LogIpvMulti2Server, Log, TEXT("MemReport %s: Map=%s UsedPhysical=%llu PeakUsedPhysical=%llu UsedVirtual=%llu UObjects=%d%s"),
+		Phase,
+		*GetWorld()->GetMapName(),
+		(uint64)MemoryStats.UsedPhysical,
+		(uint64)MemoryStats.PeakUsedPhysical,
+		(uint64)MemoryStats.UsedVirtual,
+		GUObjectArray.GetObjectArrayNumMinusAvailable(),
+		*MatchPeak);
+}
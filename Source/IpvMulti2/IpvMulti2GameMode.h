@@ -6,6 +6,8 @@
 #include "GameFramework/GameModeBase.h"
 #include "IpvMulti2GameMode.generated.h"
 
+class UIpvMulti2MatchSubsystem;
+
 UCLASS(minimalapi)
 class AIpvMulti2GameMode : public AGameModeBase
 {
@@ -13,6 +15,46 @@ class AIpvMulti2GameMode : public AGameModeBase
 
 public:
 	AIpvMulti2GameMode();
+
+	virtual void StartPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void PostLogin(APlayerController* NewPlayer) override;
+
+	/** Releases the match once the last player has left, which shuts a pooled server down. */
+	virtual void Logout(AController* Exiting) override;
+
+protected:
+	/** Match boundaries: allocation and release on pooled dedicated servers, StartPlay and EndPlay otherwise. */
+	void OnMatchStarted();
+	void OnMatchEnded();
+
+	/** Records the resident memory the match uses above its baseline, keeping the peak. */
+	void SampleMatchMemory();
+
+	/**
+	 * Logs a memreport-style summary (resident memory, UObjects) for tracking across builds. Once the match is over,
+	 * also logs the peak bytes per match and per player.
+	 */
+	void LogMemorySummary(const TCHAR* Phase, bool bIncludeMatchPeak) const;
+
+	UIpvMulti2MatchSubsystem* GetMatchSubsystem() const;
+
+private:
+	/** Resident memory when play started, the bytes-per-match baseline when there is no match subsystem. */
+	uint64 MatchStartUsedPhysical = 0;
+
+	/** Most players connected at once during this match. */
+	int32 PeakNumPlayers = 0;
+
+	/** Most resident memory above the baseline seen while the match ran. */
+	uint64 PeakMatchUsedPhysical = 0;
+
+	/** Seconds between memory samples while a match is running. */
+	float MemorySampleInterval = 1.f;
+
+	FTimerHandle MemorySampleTimerHandle;
 };
 
 
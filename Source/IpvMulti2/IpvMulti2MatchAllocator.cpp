@@ -0,0 +1,248 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IpvMulti2MatchAllocator.h"
+#include "IpvMulti2.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
+#include "HttpModule.h"
+#include "HttpPath.h"
+#include "HttpServerModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IHttpRouter.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Misc/CommandLine.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+
+UIpvMulti2MatchAllocator::UIpvMulti2MatchAllocator()
+{
+	PoolSize = 4;
+	AllocatorPort = 8700;
+	BaseGamePort = 7778;
+	ControlPortOffset = 1000;
+	StatusPollInterval = 1.f;
+}
+
+bool UIpvMulti2MatchAllocator::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return IsRunningDedicatedServer() && FParse::Param(FCommandLine::Get(), TEXT("MatchAllocator")) && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UIpvMulti2MatchAllocator::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FParse::Value(FCommandLine::Get(), TEXT("MatchPoolSize="), PoolSize);
+	FParse::Value(FCommandLine::Get(), TEXT("MatchAllocatorPort="), AllocatorPort);
+
+	Servers.SetNum(FMath::Max(1, PoolSize));
+	for (int32 Index = 0; Index < Servers.Num(); ++Index)
+	{
+		LaunchServer(Index);
+	}
+
+	HttpRouter = FHttpServerModule::Get().GetHttpRouter(AllocatorPort, /*bFailOnBindFailure*/ true);
+	if (HttpRouter.IsValid())
+	{
+		MatchRouteHandle = HttpRouter->BindRoute(
+			FHttpPath(TEXT("/match")),
+			EHttpServerRequestVerbs::VERB_POST,
+			FHttpRequestHandler::CreateUObject(this, &ThisClass::HandleMatchRequest));
+		FHttpServerModule::Get().StartAllListeners();
+		UE_LOG(LogIpvMulti2Server, Log, TEXT("Match allocator listening on port %d with a pool of %d servers"), AllocatorPort, Servers.Num());
+	}
+	else
+	{
+		UE_LOG(LogIpvMulti2Server, Error, TEXT("Failed to bind match allocator port %d"), AllocatorPort);
+	}
+
+	TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &ThisClass::Tick));
+}
+
+void UIpvMulti2MatchAllocator::Deinitialize()
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+
+	if (HttpRouter.IsValid())
+	{
+		HttpRouter->UnbindRoute(MatchRouteHandle);
+		HttpRouter.Reset();
+	}
+
+	for (FMatchServer& Server : Servers)
+	{
+		if (Server.Process.IsValid())
+		{
+			FPlatformProcess::TerminateProc(Server.Process);
+			FPlatformProcess::CloseProc(Server.Process);
+		}
+	}
+	Servers.Empty();
+
+	Super::Deinitialize();
+}
+
+void UIpvMulti2MatchAllocator::LaunchServer(int32 Index)
+{
+	FMatchServer& Server = Servers[Index];
+	Server.GamePort = BaseGamePort + Index;
+	Server.ControlPort = Server.GamePort + ControlPortOffset;
+	Server.State = EServerState::Warming;
+	Server.LaunchTime = FPlatformTime::Seconds();
+
+	FString Map = MatchMap;
+	if (Map.IsEmpty())
+	{
+		GConfig->GetString(TEXT("/Script/EngineSettings.GameMapsSettings"), TEXT("GameDefaultMap"), Map, GEngineIni);
+	}
+
+	// Uncooked runs go through the editor executable, which needs the project and -server
+	FString Params;
+	if (!FPlatformProperties::RequiresCookedData())
+	{
+		Params = FString::Printf(TEXT("\"%s\" -server "), *FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()));
+	}
+	Params += FString::Printf(TEXT("%s -port=%d -MatchControlPort=%d -log=MatchServer%d.log -unattended"),
+		*Map, Server.GamePort, Server.ControlPort, Index);
+
+	// Match servers report the address clients connect to; pass through the host the allocator was given
+	FString PublicAddress;
+	if (FParse::Value(FCommandLine::Get(), TEXT("MatchPublicAddress="), PublicAddress))
+	{
+		Params += FString::Printf(TEXT(" -MatchPublicAddress=%s"), *PublicAddress);
+	}
+
+	Server.Process = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Params, true, true, true, nullptr, 0, nullptr, nullptr);
+	if (!Server.Process.IsValid())
+	{
+		UE_LOG(LogIpvMulti2Server, Error, TEXT("Failed to launch match server %d"), Index);
+		return;
+	}
+
+	UE_LOG(LogIpvMulti2Server, Log, TEXT("Launched match server %d on game port %d, control port %d"), Index, Server.GamePort, Server.ControlPort);
+}
+
+bool UIpvMulti2MatchAllocator::Tick(float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+	if (Now < NextPollTime)
+	{
+		return true;
+	}
+	NextPollTime = Now + StatusPollInterval;
+
+	for (int32 Index = 0; Index < Servers.Num(); ++Index)
+	{
+		FMatchServer& Server = Servers[Index];
+		if (!Server.Process.IsValid() || !FPlatformProcess::IsProcRunning(Server.Process))
+		{
+			// Servers exit after every match (or crash); relaunch them so the pool stays full
+			UE_LOG(LogIpvMulti2Server, Log, TEXT("Match server %d is not running, relaunching"), Index);
+			FPlatformProcess::CloseProc(Server.Process);
+			LaunchServer(Index);
+			continue;
+		}
+
+		PollStatus(Index);
+	}
+	return true;
+}
+
+void UIpvMulti2MatchAllocator::PollStatus(int32 Index)
+{
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> HttpRequest = FHttpModule::Get().CreateRequest();
+	HttpRequest->SetURL(GetControlUrl(Servers[Index], TEXT("/status")));
+	HttpRequest->SetVerb(TEXT("GET"));
+	HttpRequest->OnProcessRequestComplete().BindWeakLambda(this, [this, Index](FHttpRequestPtr, FHttpResponsePtr Response, bool bConnectedSuccessfully)
+	{
+		if (!Servers.IsValidIndex(Index)) return;
+
+		FMatchServer& Server = Servers[Index];
+		const EServerState PreviousState = Server.State;
+		if (!bConnectedSuccessfully || !Response.IsValid())
+		{
+			Server.State = EServerState::Warming;
+		}
+		else if (Response->GetContentAsString().Contains(TEXT("\"idle\"")))
+		{
+			Server.State = EServerState::Idle;
+		}
+		else if (Response->GetContentAsString().Contains(TEXT("\"busy\"")))
+		{
+			Server.State = EServerState::Busy;
+		}
+		else
+		{
+			Server.State = EServerState::Warming;
+		}
+
+		if (PreviousState == EServerState::Warming && Server.State == EServerState::Idle)
+		{
+			UE_LOG(LogIpvMulti2Server, Log, TEXT("Match server %d warm after %.1f ms"), Index, (FPlatformTime::Seconds() - Server.LaunchTime) * 1000.0);
+		}
+	});
+	HttpRequest->ProcessRequest();
+}
+
+bool UIpvMulti2MatchAllocator::HandleMatchRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+	TSharedRef<FPendingAllocation> Allocation = MakeShared<FPendingAllocation>();
+	Allocation->OnComplete = OnComplete;
+	Allocation->RequestTime = FPlatformTime::Seconds();
+	if (const FString* MatchType = Request.QueryParams.Find(TEXT("matchType")))
+	{
+		Allocation->Query = FString::Printf(TEXT("?matchType=%s"), *FGenericPlatformHttp::UrlEncode(*MatchType));
+	}
+
+	TryAllocate(Allocation);
+	return true;
+}
+
+void UIpvMulti2MatchAllocator::TryAllocate(TSharedRef<FPendingAllocation> Allocation)
+{
+	int32 Index = Allocation->NextCandidate;
+	while (Servers.IsValidIndex(Index) && Servers[Index].State != EServerState::Idle)
+	{
+		++Index;
+	}
+
+	if (!Servers.IsValidIndex(Index))
+	{
+		UE_LOG(LogIpvMulti2Server, Warning, TEXT("No idle match server in the pool"));
+		Allocation->OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::ServiceUnavail, TEXT("pool_exhausted"), TEXT("No idle match server in the pool")));
+		return;
+	}
+
+	// Reserve the server so concurrent requests don't pick it too; its status poll corrects this if the request fails
+	Allocation->NextCandidate = Index + 1;
+	Servers[Index].State = EServerState::Busy;
+
+	TSharedRef<IHttpRequest, ESPMode::ThreadSafe> HttpRequest = FHttpModule::Get().CreateRequest();
+	HttpRequest->SetURL(GetControlUrl(Servers[Index], TEXT("/match")) + Allocation->Query);
+	HttpRequest->SetVerb(TEXT("POST"));
+	HttpRequest->OnProcessRequestComplete().BindWeakLambda(this, [this, Allocation, Index](FHttpRequestPtr, FHttpResponsePtr Response, bool bConnectedSuccessfully)
+	{
+		if (!bConnectedSuccessfully || !Response.IsValid() || Response->GetResponseCode() != EHttpResponseCodes::Ok)
+		{
+			// Busy or still warming after all: try the next server
+			TryAllocate(Allocation);
+			return;
+		}
+
+		const double RequestToReadyMs = (FPlatformTime::Seconds() - Allocation->RequestTime) * 1000.0;
+		UE_LOG(LogIpvMulti2Server, Log, TEXT("Allocated match server %d (game port %d): request to accepting connections %.1f ms"),
+			Index, Servers[Index].GamePort, RequestToReadyMs);
+
+		const FString Body = FString::Printf(TEXT("{\"server\":%d,\"allocatorRequestToReadyMs\":%.1f,\"match\":%s}"),
+			Index, RequestToReadyMs, *Response->GetContentAsString());
+		Allocation->OnComplete(FHttpServerResponse::Create(Body, TEXT("application/json")));
+	});
+	HttpRequest->ProcessRequest();
+}
+
+FString UIpvMulti2MatchAllocator::GetControlUrl(const FMatchServer& Server, const TCHAR* Path) const
+{
+	return FString::Printf(TEXT("http://127.0.0.1:%d%s"), Server.ControlPort, Path);
+}
@@ -0,0 +1,106 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "HAL/PlatformProcess.h"
+#include "HttpResultCallback.h"
+#include "HttpRouteHandle.h"
+#include "IpvMulti2MatchAllocator.generated.h"
+
+class IHttpRouter;
+struct FHttpServerRequest;
+
+/**
+ * Local match allocator. Runs in a dedicated server started with -MatchAllocator, keeps PoolSize
+ * match servers warm (map loaded, see UIpvMulti2MatchSubsystem) and exposes a single POST /match
+ * endpoint that hands the request to the first idle server. Match servers exit when their match
+ * ends; those and any that crash are relaunched.
+ */
+UCLASS(config=Game)
+class UIpvMulti2MatchAllocator : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UIpvMulti2MatchAllocator();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+protected:
+	/** Number of match servers kept running. */
+	UPROPERTY(Config)
+	int32 PoolSize;
+
+	/** Port of the allocator's own /match endpoint. */
+	UPROPERTY(Config)
+	int32 AllocatorPort;
+
+	/** Game port of the first match server; the others follow consecutively. Keep clear of the allocator's own game port. */
+	UPROPERTY(Config)
+	int32 BaseGamePort;
+
+	/** Added to each match server's game port to get its control port. */
+	UPROPERTY(Config)
+	int32 ControlPortOffset;
+
+	/** Map the match servers load. Empty uses the game default map. */
+	UPROPERTY(Config)
+	FString MatchMap;
+
+	/** Seconds between status polls of the pool. */
+	UPROPERTY(Config)
+	float StatusPollInterval;
+
+	enum class EServerState : uint8
+	{
+		Warming,
+		Idle,
+		Busy
+	};
+
+	struct FMatchServer
+	{
+		FProcHandle Process;
+		int32 GamePort = 0;
+		int32 ControlPort = 0;
+		EServerState State = EServerState::Warming;
+		double LaunchTime = 0.0;
+	};
+
+	/** A /match request waiting for a server to accept it. */
+	struct FPendingAllocation
+	{
+		FHttpResultCallback OnComplete;
+		FString Query;
+		double RequestTime = 0.0;
+		int32 NextCandidate = 0;
+	};
+
+	void LaunchServer(int32 Index);
+
+	bool Tick(float DeltaTime);
+
+	void PollStatus(int32 Index);
+
+	bool HandleMatchRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+
+	/** Offers the request to the next idle server, answering 503 when the pool is exhausted. */
+	void TryAllocate(TSharedRef<FPendingAllocation> Allocation);
+
+	FString GetControlUrl(const FMatchServer& Server, const TCHAR* Path) const;
+
+private:
+	TArray<FMatchServer> Servers;
+
+	TSharedPtr<IHttpRouter> HttpRouter;
+	FHttpRouteHandle MatchRouteHandle;
+
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	double NextPollTime = 0.0;
+};
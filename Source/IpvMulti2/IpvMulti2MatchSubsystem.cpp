@@ -0,0 +1,278 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "IpvMulti2MatchSubsystem.h"
+#include "IpvMulti2.h"
+#include "CoreGlobals.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/GameModeBase.h"
+#include "Engine/NetDriver.h"
+#include "HAL/PlatformMemory.h"
+#include "HttpPath.h"
+#include "HttpServerModule.h"
+#include "HttpServerRequest.h"
+#include "HttpServerResponse.h"
+#include "IHttpRouter.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "OnlineSubsystem.h"
+#include "OnlineSessionSettings.h"
+#include "TimerManager.h"
+#include "UObject/UObjectGlobals.h"
+
+UIpvMulti2MatchSubsystem::UIpvMulti2MatchSubsystem():
+CreateSessionCompleteDelegate(FOnCreateSessionCompleteDelegate::CreateUObject(this, &ThisClass::OnCreateSessionComplete)),
+DestroySessionCompleteDelegate(FOnDestroySessionCompleteDelegate::CreateUObject(this, &ThisClass::OnDestroySessionComplete))
+{
+	ControlPortOffset = 1000;
+	NumPublicConnections = 4;
+	DefaultMatchType = TEXT("FreeForAll");
+	PublicAddress = TEXT("127.0.0.1");
+	JoinTimeout = 60.f;
+}
+
+bool UIpvMulti2MatchSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Only dedicated servers are allocated as matches; the allocator process itself hosts none
+	return IsRunningDedicatedServer() && !FParse::Param(FCommandLine::Get(), TEXT("MatchAllocator")) && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UIpvMulti2MatchSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	IOnlineSubsystem* OnlineSubsystem = IOnlineSubsystem::Get();
+	if (OnlineSubsystem)
+	{
+		OnlineSessionInterface = OnlineSubsystem->GetSessionInterface();
+	}
+
+	FParse::Value(FCommandLine::Get(), TEXT("MatchPublicAddress="), PublicAddress);
+
+	PostLoadMapDelegateHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &ThisClass::OnPostLoadMap);
+}
+
+void UIpvMulti2MatchSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapDelegateHandle);
+
+	if (HttpRouter.IsValid())
+	{
+		HttpRouter->UnbindRoute(StatusRouteHandle);
+		HttpRouter->UnbindRoute(MatchRouteHandle);
+		HttpRouter.Reset();
+	}
+
+	if (OnlineSessionInterface.IsValid())
+	{
+		OnlineSessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+		OnlineSessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+		if (bMatchAllocated)
+		{
+			OnlineSessionInterface->DestroySession(NAME_GameSession);
+		}
+	}
+
+	Super::Deinitialize();
+}
+
+void UIpvMulti2MatchSubsystem::OnPostLoadMap(UWorld* LoadedWorld)
+{
+	if (!LoadedWorld || LoadedWorld != GetGameInstance()->GetWorld()) return;
+
+	WarmUpSeconds = FPlatformTime::Seconds() - GStartTime;
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	WarmUsedPhysical = MemoryStats.UsedPhysical;
+	UE_LOG(LogIpvMulti2Server, Log, TEXT("Server warm: map %s loaded in %.1f ms, %.1f MiB resident"),
+		*LoadedWorld->GetMapName(), WarmUpSeconds * 1000.0, MemoryStats.UsedPhysical / (1024.0 * 1024.0));
+
+	StartListening();
+}
+
+void UIpvMulti2MatchSubsystem::StartListening()
+{
+	if (HttpRouter.IsValid()) return;
+
+	UWorld* World = GetGameInstance()->GetWorld();
+	if (!World) return;
+
+	// Servers sharing a host each need their own control port; the allocator passes -MatchControlPort= per process
+	ControlPort = World->URL.Port + ControlPortOffset;
+	FParse::Value(FCommandLine::Get(), TEXT("MatchControlPort="), ControlPort);
+
+	HttpRouter = FHttpServerModule::Get().GetHttpRouter(ControlPort, /*bFailOnBindFailure*/ true);
+	if (!HttpRouter.IsValid())
+	{
+		UE_LOG(LogIpvMulti2Server, Error, TEXT("Failed to bind match control port %u"), ControlPort);
+		return;
+	}
+
+	StatusRouteHandle = HttpRouter->BindRoute(
+		FHttpPath(TEXT("/status")),
+		EHttpServerRequestVerbs::VERB_GET,
+		FHttpRequestHandler::CreateUObject(this, &ThisClass::HandleStatusRequest));
+	MatchRouteHandle = HttpRouter->BindRoute(
+		FHttpPath(TEXT("/match")),
+		EHttpServerRequestVerbs::VERB_POST,
+		FHttpRequestHandler::CreateUObject(this, &ThisClass::HandleMatchRequest));
+	FHttpServerModule::Get().StartAllListeners();
+
+	UE_LOG(LogIpvMulti2Server, Log, TEXT("Accepting match requests on port %u (game port %d)"), ControlPort, World->URL.Port);
+}
+
+bool UIpvMulti2MatchSubsystem::IsWarm() const
+{
+	const UWorld* World = GetGameInstance()->GetWorld();
+	return World && World->HasBegunPlay() && World->GetNetDriver();
+}
+
+bool UIpvMulti2MatchSubsystem::HandleStatusRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+	const TCHAR* State = !IsWarm() ? TEXT("warming") : (bMatchAllocated || bReleasingMatch || PendingResponse) ? TEXT("busy") : TEXT("idle");
+	OnComplete(FHttpServerResponse::Create(FString::Printf(TEXT("{\"state\":\"%s\"}"), State), TEXT("application/json")));
+	return true;
+}
+
+bool UIpvMulti2MatchSubsystem::HandleMatchRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete)
+{
+	// One match per process: a busy or still-loading server tells the allocator to try the next one
+	if (bMatchAllocated || bReleasingMatch || PendingResponse || !IsWarm())
+	{
+		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::ServiceUnavail, TEXT("busy"), TEXT("Server is not available for a new match")));
+		return true;
+	}
+
+	if (!OnlineSessionInterface.IsValid())
+	{
+		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::ServerError, TEXT("no_session_interface"), TEXT("Online subsystem has no session interface")));
+		return true;
+	}
+
+	MatchRequestTime = FPlatformTime::Seconds();
+	PendingResponse = OnComplete;
+
+	const FString* RequestedMatchType = Request.QueryParams.Find(TEXT("matchType"));
+	const FString MatchType = RequestedMatchType ? *RequestedMatchType : DefaultMatchType;
+
+	//Delegate-List
+	CreateSessionCompleteDelegateHandle = OnlineSessionInterface->AddOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegate);
+	//CreateSession
+	FOnlineSessionSettings SessionSettings;
+	SessionSettings.bIsDedicated = true;
+	SessionSettings.bIsLANMatch = false;
+	SessionSettings.NumPublicConnections = NumPublicConnections;
+	SessionSettings.bAllowJoinInProgress = true;
+	SessionSettings.bShouldAdvertise = true;
+	SessionSettings.bUsesPresence = false;
+	SessionSettings.bUseLobbiesIfAvailable = false;
+	SessionSettings.Set(FName("MatchType"), MatchType, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+
+	if (!OnlineSessionInterface->CreateSession(0, NAME_GameSession, SessionSettings))
+	{
+		OnlineSessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+		CompleteMatchRequest(false);
+	}
+	return true;
+}
+
+uint64 UIpvMulti2MatchSubsystem::GetMatchUsedPhysical() const
+{
+	const uint64 UsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+	return UsedPhysical > WarmUsedPhysical ? UsedPhysical - WarmUsedPhysical : 0;
+}
+
+void UIpvMulti2MatchSubsystem::ReleaseMatch()
+{
+	if (!bMatchAllocated) return;
+
+	GetGameInstance()->GetTimerManager().ClearTimer(JoinTimeoutHandle);
+
+	OnMatchEnded.Broadcast();
+
+	bMatchAllocated = false;
+	bReleasingMatch = true;
+	if (!OnlineSessionInterface.IsValid())
+	{
+		ShutdownReleasedServer();
+		return;
+	}
+
+	// Destroying the session is asynchronous (Steam): wait for it so the online service doesn't keep advertising it
+	//Delegate-List
+	DestroySessionCompleteDelegateHandle = OnlineSessionInterface->AddOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegate);
+	if (!OnlineSessionInterface->DestroySession(NAME_GameSession))
+	{
+		OnDestroySessionComplete(NAME_GameSession, false);
+	}
+}
+
+void UIpvMulti2MatchSubsystem::OnDestroySessionComplete(FName SessionName, bool bWasSuccess)
+{
+	if (SessionName != NAME_GameSession || !bReleasingMatch) return;
+
+	OnlineSessionInterface->ClearOnDestroySessionCompleteDelegate_Handle(DestroySessionCompleteDelegateHandle);
+
+	if (!bWasSuccess)
+	{
+		UE_LOG(LogIpvMulti2Server, Warning, TEXT("Destroy Session Failed"));
+	}
+	ShutdownReleasedServer();
+}
+
+void UIpvMulti2MatchSubsystem::ShutdownReleasedServer()
+{
+	// The world still holds the finished match's actors and whatever it leaked; a fresh process is the only clean reset.
+	// The allocator notices the exit and launches a warm replacement.
+	UE_LOG(LogIpvMulti2Server, Log, TEXT("Match released, shutting down for the allocator to replace this server"));
+	RequestEngineExit(TEXT("Match released"));
+}
+
+void UIpvMulti2MatchSubsystem::OnCreateSessionComplete(FName SessionName, bool bWasSuccess)
+{
+	if (SessionName != NAME_GameSession) return;
+
+	OnlineSessionInterface->ClearOnCreateSessionCompleteDelegate_Handle(CreateSessionCompleteDelegateHandle);
+	CompleteMatchRequest(bWasSuccess);
+}
+
+void UIpvMulti2MatchSubsystem::CompleteMatchRequest(bool bWasSuccess)
+{
+	if (!PendingResponse) return;
+
+	FHttpResultCallback OnComplete = MoveTemp(PendingResponse);
+	PendingResponse = nullptr;
+
+	if (!bWasSuccess)
+	{
+		UE_LOG(LogIpvMulti2Server, Warning, TEXT("Create Session Failed"));
+		OnComplete(FHttpServerResponse::Error(EHttpServerResponseCodes::ServerError, TEXT("create_session_failed"), TEXT("Create Session Failed")));
+		return;
+	}
+
+	bMatchAllocated = true;
+	GetGameInstance()->GetTimerManager().SetTimer(JoinTimeoutHandle, this, &ThisClass::OnJoinTimeout, JoinTimeout, false);
+
+	const double RequestToReadyMs = (FPlatformTime::Seconds() - MatchRequestTime) * 1000.0;
+	const FPlatformMemoryStats MemoryStats = FPlatformMemory::GetStats();
+	const int32 GamePort = GetGameInstance()->GetWorld()->URL.Port;
+
+	UE_LOG(LogIpvMulti2Server, Log, TEXT("Match ready on port %d: request to accepting connections %.1f ms (warm-up %.1f ms), %llu bytes resident, %llu bytes peak"),
+		GamePort, RequestToReadyMs, WarmUpSeconds * 1000.0, (uint64)MemoryStats.UsedPhysical, (uint64)MemoryStats.PeakUsedPhysical);
+
+	OnMatchStarted.Broadcast();
+
+	const FString Body = FString::Printf(
+		TEXT("{\"session\":\"%s\",\"address\":\"%s:%d\",\"port\":%d,\"requestToReadyMs\":%.1f,\"warmUpMs\":%.1f,\"usedPhysicalBytes\":%llu,\"peakUsedPhysicalBytes\":%llu}"),
+		*NAME_GameSession.ToString(), *PublicAddress, GamePort, GamePort, RequestToReadyMs, WarmUpSeconds * 1000.0, (uint64)MemoryStats.UsedPhysical, (uint64)MemoryStats.PeakUsedPhysical);
+	OnComplete(FHttpServerResponse::Create(Body, TEXT("application/json")));
+}
+
+void UIpvMulti2MatchSubsystem::OnJoinTimeout()
+{
+	const UWorld* World = GetGameInstance()->GetWorld();
+	const AGameModeBase* GameMode = World ? World->GetAuthGameMode() : nullptr;
+	if (!bMatchAllocated || (GameMode && GameMode->GetNumPlayers() > 0)) return;
+
+	UE_LOG(LogIpvMulti2Server, Warning, TEXT("Nobody joined the match within %.0f s, releasing it"), JoinTimeout);
+	ReleaseMatch();
+}
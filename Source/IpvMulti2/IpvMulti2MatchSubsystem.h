@@ -0,0 +1,132 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "HttpResultCallback.h"
+#include "HttpRouteHandle.h"
+#include "Interfaces/OnlineSessionDelegates.h"
+#include "Interfaces/OnlineSessionInterface.h"
+#include "IpvMulti2MatchSubsystem.generated.h"
+
+class IHttpRouter;
+struct FHttpServerRequest;
+
+DECLARE_MULTICAST_DELEGATE(FOnIpvMulti2MatchLifecycle);
+
+/**
+ * Match endpoint of a pre-warmed dedicated server in the allocator's pool.
+ *
+ * The server loads its map up front and then listens on a local HTTP control port
+ * (-MatchControlPort=, or game port + ControlPortOffset). GET /status reports whether it can take a
+ * match; POST /match registers the game session with the online subsystem and answers with the
+ * address clients connect to once the server is accepting connections. The session is not a presence
+ * session, so clients join through that address rather than through a session search. When the last player leaves, the session is destroyed and the process
+ * exits, so no match inherits another's world or memory; the allocator launches a fresh server in its place.
+ */
+UCLASS(config=Game)
+class UIpvMulti2MatchSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UIpvMulti2MatchSubsystem();
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Ends the current match: destroys the game session, then shuts the server down for the allocator to replace. */
+	void ReleaseMatch();
+
+	FORCEINLINE bool IsMatchAllocated() const { return bMatchAllocated; }
+
+	/** Resident memory above what the warm, idle server used right after loading its map. The game mode tracks its peak per match. */
+	uint64 GetMatchUsedPhysical() const;
+
+	/** Broadcast once the session is registered and the server accepts connections. */
+	FOnIpvMulti2MatchLifecycle OnMatchStarted;
+
+	/** Broadcast when the match is released, before its session is destroyed. */
+	FOnIpvMulti2MatchLifecycle OnMatchEnded;
+
+protected:
+	/** Offset added to the game port to get the local control port when -MatchControlPort= is not given. */
+	UPROPERTY(Config)
+	int32 ControlPortOffset;
+
+	/** Players per match, advertised in the session settings. */
+	UPROPERTY(Config)
+	int32 NumPublicConnections;
+
+	/** Match type used when the request does not specify one. */
+	UPROPERTY(Config)
+	FString DefaultMatchType;
+
+	/** Host clients connect to, returned with the game port as "address" in the /match response. -MatchPublicAddress= overrides it. */
+	UPROPERTY(Config)
+	FString PublicAddress;
+
+	/** Seconds an allocated match waits for its first player before it is released. */
+	UPROPERTY(Config)
+	float JoinTimeout;
+
+	void OnPostLoadMap(UWorld* LoadedWorld);
+
+	void StartListening();
+
+	bool IsWarm() const;
+
+	bool HandleStatusRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+
+	bool HandleMatchRequest(const FHttpServerRequest& Request, const FHttpResultCallback& OnComplete);
+
+	//Callbacks
+	void OnCreateSessionComplete(FName SessionName, bool bWasSuccess);
+	void OnDestroySessionComplete(FName SessionName, bool bWasSuccess);
+
+	/** Exits the process once a match is over. */
+	void ShutdownReleasedServer();
+
+	/** Answers the pending match request and logs timing and memory for the match. */
+	void CompleteMatchRequest(bool bWasSuccess);
+
+	/** Releases a match that nobody joined, so abandoned allocations don't hold on to pool servers. */
+	void OnJoinTimeout();
+
+private:
+
+	IOnlineSessionPtr OnlineSessionInterface;
+
+	//Delegate
+	FOnCreateSessionCompleteDelegate CreateSessionCompleteDelegate;
+	FOnDestroySessionCompleteDelegate DestroySessionCompleteDelegate;
+
+	FDelegateHandle CreateSessionCompleteDelegateHandle;
+	FDelegateHandle DestroySessionCompleteDelegateHandle;
+	FDelegateHandle PostLoadMapDelegateHandle;
+
+	TSharedPtr<IHttpRouter> HttpRouter;
+	FHttpRouteHandle StatusRouteHandle;
+	FHttpRouteHandle MatchRouteHandle;
+	uint32 ControlPort = 0;
+
+	/** Callback of the request currently being served, empty when idle. */
+	FHttpResultCallback PendingResponse;
+
+	bool bMatchAllocated = false;
+
+	/** Set once the match is released; the server reports busy from then until it exits. */
+	bool bReleasingMatch = false;
+
+	/** Seconds from process start until the map finished loading. */
+	double WarmUpSeconds = 0.0;
+
+	/** Resident memory of the warm server before any match, the baseline for GetMatchUsedPhysical. */
+	uint64 WarmUsedPhysical = 0;
+
+	double MatchRequestTime = 0.0;
+
+	FTimerHandle JoinTimeoutHandle;
+};
@@ -0,0 +1,519 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && WITH_EDITOR
+
+#include "IpvMulti2Character.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Editor.h"
+#include "Engine/DamageEvents.h"
+#include "Engine/Engine.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/ConfigCacheIni.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Settings/LevelEditorPlaySettings.h"
+#include "Tests/AutomationCommon.h"
+
+static TAutoConsoleVariable<float> CVarNetConvergenceTimeout(
+	TEXT("IpvNet.ConvergenceTimeout"),
+	5.f,
+	TEXT("Seconds a state change may take to reach every client before IpvMulti2.Network.Convergence fails."));
+
+static TAutoConsoleVariable<int32> CVarNetConvergenceIterations(
+	TEXT("IpvNet.ConvergenceIterations"),
+	10,
+	TEXT("Fire/kill/respawn/pickup cycles IpvMulti2.Network.Convergence runs per packet simulation profile."));
+
+namespace IpvMulti2NetConvergenceTest
+{
+	const TCHAR* MapName = TEXT("/Game/ThirdPerson/Maps/ThirdPersonMap");
+	const TCHAR* CleanProfile = TEXT("Clean");
+	const TCHAR* ProfileSectionPrefix = TEXT("PacketSimulationProfile.");
+
+	/** Clients besides the listen server host, each owning one of the characters under test. */
+	constexpr int32 NumClients = 2;
+
+	constexpr double ConnectTimeoutSeconds = 30.0;
+
+	/** Time to let the connections settle after switching packet simulation profile. */
+	constexpr double SettleSeconds = 1.0;
+
+	UWorld* FindServerWorld()
+	{
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			UWorld* World = Context.World();
+			if (World && Context.WorldType == EWorldType::PIE && World->GetNetMode() == NM_ListenServer)
+			{
+				return World;
+			}
+		}
+		return nullptr;
+	}
+
+	void GetClientWorlds(TArray<UWorld*>& OutClientWorlds)
+	{
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			UWorld* World = Context.World();
+			if (World && Context.WorldType == EWorldType::PIE && World->GetNetMode() == NM_Client)
+			{
+				OutClientWorlds.Add(World);
+			}
+		}
+	}
+
+	AIpvMulti2Character* FindCharacter(UWorld* World, int32 PlayerId)
+	{
+		if (!World) return nullptr;
+
+		for (TActorIterator<AIpvMulti2Character> It(World); It; ++It)
+		{
+			const APlayerState* PlayerState = It->GetPlayerState();
+			if (PlayerState && PlayerState->GetPlayerId() == PlayerId)
+			{
+				return *It;
+			}
+		}
+		return nullptr;
+	}
+
+	/** The client-side character the player with PlayerId controls. */
+	AIpvMulti2Character* FindOwningProxy(int32 PlayerId)
+	{
+		TArray<UWorld*> ClientWorlds;
+		GetClientWorlds(ClientWorlds);
+		for (UWorld* ClientWorld : ClientWorlds)
+		{
+			AIpvMulti2Character* Proxy = FindCharacter(ClientWorld, PlayerId);
+			if (Proxy && Proxy->IsLocallyControlled())
+			{
+				return Proxy;
+			}
+		}
+		return nullptr;
+	}
+
+	/** Loads a PacketSimulationProfile.<Name> section; "Clean" turns emulation off. */
+	bool LoadProfile(const FString& Profile, FPacketSimulationSettings& OutSettings)
+	{
+#if DO_ENABLE_NET_TEST
+		OutSettings = FPacketSimulationSettings();
+		return Profile == CleanProfile || OutSettings.LoadEmulationProfile(*Profile);
+#else
+		return Profile == CleanProfile;
+#endif
+	}
+
+	double Percentile(const TArray<double>& SortedSamples, double Fraction)
+	{
+		if (SortedSamples.Num() == 0) return 0.0;
+		const int32 Index = FMath::Clamp(FMath::CeilToInt32(Fraction * SortedSamples.Num()) - 1, 0, SortedSamples.Num() - 1);
+		return SortedSamples[Index];
+	}
+}
+
+/** Starts a listen server PIE session with NumClients extra clients, all in this process. */
+class FIpvMulti2StartMultiplayerPIECommand : public IAutomationLatentCommand
+{
+public:
+	virtual bool Update() override
+	{
+		ULevelEditorPlaySettings* PlaySettings = NewObject<ULevelEditorPlaySettings>();
+		PlaySettings->SetPlayNetMode(EPlayNetMode::PIE_ListenServer);
+		PlaySettings->SetPlayNumberOfClients(IpvMulti2NetConvergenceTest::NumClients + 1);
+		PlaySettings->SetRunUnderOneProcess(true);
+
+		FRequestPlaySessionParams Params;
+		Params.WorldType = EPlaySessionWorldType::PlayInEditor;
+		Params.EditorPlaySettings = PlaySettings;
+		GEditor->RequestPlaySession(Params);
+		return true;
+	}
+};
+
+/**
+ * Replays kill, respawn, fire and pickup on each client-owned character under one packet simulation
+ * profile, through the same entry points gameplay uses, and waits for every client to show the server's
+ * health, ammo and ragdoll state. A change that misses IpvNet.ConvergenceTimeout fails the test;
+ * latency percentiles are reported as test info and written to Saved/Profiling.
+ */
+class FIpvMulti2NetConvergenceCommand : public IAutomationLatentCommand
+{
+public:
+	FIpvMulti2NetConvergenceCommand(FAutomationTestBase* InTest, const FString& InProfile)
+		: Test(InTest)
+		, Profile(InProfile)
+		, Iterations(FMath::Max(1, CVarNetConvergenceIterations.GetValueOnGameThread()))
+	{
+	}
+
+	virtual bool Update() override
+	{
+		const double Now = FPlatformTime::Seconds();
+		if (StartTime == 0.0)
+		{
+			StartTime = Now;
+		}
+
+		switch (Phase)
+		{
+		case EPhase::WaitForPlayers:
+			return UpdateWaitForPlayers(Now);
+		case EPhase::Settle:
+			if (Now >= SettleUntilTime)
+			{
+				Phase = EPhase::Running;
+			}
+			return false;
+		case EPhase::Running:
+			return UpdateRunning(Now);
+		default:
+			return true;
+		}
+	}
+
+private:
+	enum class EPhase : uint8
+	{
+		WaitForPlayers,
+		Settle,
+		Running
+	};
+
+	/** Fire comes first so the character dies with ammo spent and Respawn has to restore it across the link. */
+	enum class EStep : uint8
+	{
+		Fire,
+		Kill,
+		Respawn,
+		Pickup,
+		Num
+	};
+
+	static const TCHAR* GetStepName(EStep InStep)
+	{
+		switch (InStep)
+		{
+		case EStep::Fire:		return TEXT("Fire");
+		case EStep::Kill:		return TEXT("Kill");
+		case EStep::Respawn:	return TEXT("Respawn");
+		case EStep::Pickup:		return TEXT("Pickup");
+		default:				return TEXT("Unknown");
+		}
+	}
+
+	bool UpdateWaitForPlayers(double Now)
+	{
+		using namespace IpvMulti2NetConvergenceTest;
+
+		UWorld* ServerWorld = FindServerWorld();
+		TArray<UWorld*> ClientWorlds;
+		GetClientWorlds(ClientWorlds);
+
+		TArray<int32> PlayerIds;
+		if (ServerWorld)
+		{
+			for (TActorIterator<AIpvMulti2Character> It(ServerWorld); It; ++It)
+			{
+				if (!It->IsLocallyControlled() && It->GetPlayerState())
+				{
+					PlayerIds.Add(It->GetPlayerState()->GetPlayerId());
+				}
+			}
+		}
+
+		bool bReady = PlayerIds.Num() >= NumClients && ClientWorlds.Num() >= NumClients;
+		for (int32 PlayerId : PlayerIds)
+		{
+			bReady = bReady && FindOwningProxy(PlayerId) != nullptr;
+			for (UWorld* ClientWorld : ClientWorlds)
+			{
+				bReady = bReady && FindCharacter(ClientWorld, PlayerId) != nullptr;
+			}
+		}
+
+		if (!bReady)
+		{
+			if (Now - StartTime > ConnectTimeoutSeconds)
+			{
+				Test->AddError(FString::Printf(TEXT("%d clients did not connect and replicate their characters within %.0f s"), NumClients, ConnectTimeoutSeconds));
+				return true;
+			}
+			return false;
+		}
+
+		TargetPlayerIds = PlayerIds;
+		ApplyProfile(Profile);
+		SettleUntilTime = Now + SettleSeconds;
+		Phase = EPhase::Settle;
+		return false;
+	}
+
+	bool UpdateRunning(double Now)
+	{
+		if (!IpvMulti2NetConvergenceTest::FindServerWorld())
+		{
+			Test->AddError(TEXT("PIE session ended before the run finished"));
+			Finish();
+			return true;
+		}
+
+		if (TargetPlayerId == INDEX_NONE)
+		{
+			if (!BeginStep(Now))
+			{
+				Test->AddError(FString::Printf(TEXT("%s iteration %d: character for player %d is gone"), GetStepName(Step), Iteration, TargetPlayerIds[Iteration % TargetPlayerIds.Num()]));
+				return Advance();
+			}
+			return false;
+		}
+
+		TArray<UWorld*> ClientWorlds;
+		IpvMulti2NetConvergenceTest::GetClientWorlds(ClientWorlds);
+
+		FString Mismatch;
+		bool bConverged = true;
+		for (UWorld* ClientWorld : ClientWorlds)
+		{
+			if (!HasConverged(ClientWorld, Mismatch))
+			{
+				bConverged = false;
+				break;
+			}
+		}
+
+		const double ElapsedSeconds = Now - StepStartTime;
+		if (bConverged)
+		{
+			LatencyMs[(int32)Step].Add(ElapsedSeconds * 1000.0);
+		}
+		else if (ElapsedSeconds > CVarNetConvergenceTimeout.GetValueOnGameThread())
+		{
+			++Timeouts[(int32)Step];
+			Test->AddError(FString::Printf(TEXT("%s iteration %d did not converge in %.1f s (%s)"), GetStepName(Step), Iteration, ElapsedSeconds, *Mismatch));
+		}
+		else
+		{
+			return false;
+		}
+
+		return Advance();
+	}
+
+	bool BeginStep(double Now)
+	{
+		using namespace IpvMulti2NetConvergenceTest;
+
+		const int32 PlayerId = TargetPlayerIds[Iteration % TargetPlayerIds.Num()];
+		AIpvMulti2Character* Target = FindCharacter(FindServerWorld(), PlayerId);
+		if (!Target) return false;
+
+		switch (Step)
+		{
+		case EStep::Fire:
+		{
+			// Same path as the FireAction binding: the owning client sends ServerFire across the emulated link
+			AIpvMulti2Character* OwningProxy = FindOwningProxy(PlayerId);
+			if (!OwningProxy) return false;
+			OwningProxy->RequestFire();
+			break;
+		}
+		case EStep::Kill:
+			// The owning client answers the replicated health with ServerStartRagdoll, so this covers the round trip
+			Target->TakeDamage(Target->GetMaxHealth(), FDamageEvent(), nullptr, nullptr);
+			break;
+		case EStep::Respawn:
+		{
+			// Requested by the owning client, so the ServerRespawn RPC crosses the emulated link too
+			AIpvMulti2Character* OwningProxy = FindOwningProxy(PlayerId);
+			if (!OwningProxy) return false;
+			OwningProxy->RequestRespawn();
+			break;
+		}
+		case EStep::Pickup:
+			Target->AddAmmo(Target->GetMaxAmmo());
+			break;
+		default:
+			break;
+		}
+
+		// Fire and Respawn land on the server later, once their RPC arrives
+		ExpectedAmmo = Step == EStep::Respawn ? Target->GetMaxAmmo()
+			: Step == EStep::Fire ? FMath::Max(Target->GetCurrentAmmo() - 1, 0)
+			: Target->GetCurrentAmmo();
+		TargetPlayerId = PlayerId;
+		StepStartTime = Now;
+		return true;
+	}
+
+	bool HasConverged(UWorld* ClientWorld, FString& OutMismatch) const
+	{
+		const AIpvMulti2Character* Proxy = IpvMulti2NetConvergenceTest::FindCharacter(ClientWorld, TargetPlayerId);
+		if (!Proxy)
+		{
+			OutMismatch = TEXT("character not replicated");
+			return false;
+		}
+
+		const USkeletalMeshComponent* MeshComp = Proxy->GetMesh();
+		const bool bSimulatingPhysics = MeshComp && MeshComp->IsSimulatingPhysics();
+
+		OutMismatch = FString::Printf(TEXT("client sees health %.1f, ammo %d (expected %d), ragdoll %d, simulating %d"),
+			Proxy->GetCurrentHealth(), Proxy->GetCurrentAmmo(), ExpectedAmmo, Proxy->IsRagdoll(), bSimulatingPhysics);
+
+		switch (Step)
+		{
+		case EStep::Kill:
+			return Proxy->GetCurrentHealth() <= 0.f && Proxy->IsRagdoll() && bSimulatingPhysics;
+		case EStep::Respawn:
+			return Proxy->GetCurrentHealth() == Proxy->GetMaxHealth() && Proxy->GetCurrentAmmo() == ExpectedAmmo
+				&& !Proxy->IsRagdoll() && !bSimulatingPhysics;
+		case EStep::Fire:
+		case EStep::Pickup:
+			return Proxy->GetCurrentAmmo() == ExpectedAmmo;
+		default:
+			return true;
+		}
+	}
+
+	/** Moves to the next step; returns true once every iteration has run. */
+	bool Advance()
+	{
+		TargetPlayerId = INDEX_NONE;
+		Step = (EStep)((int32)Step + 1);
+		if (Step == EStep::Num)
+		{
+			Step = EStep::Fire;
+			++Iteration;
+		}
+
+		if (Iteration < Iterations)
+		{
+			return false;
+		}
+
+		Finish();
+		return true;
+	}
+
+	void ApplyProfile(const FString& InProfile) const
+	{
+#if DO_ENABLE_NET_TEST
+		FPacketSimulationSettings Settings;
+		IpvMulti2NetConvergenceTest::LoadProfile(InProfile, Settings);
+
+		TArray<UWorld*> Worlds;
+		IpvMulti2NetConvergenceTest::GetClientWorlds(Worlds);
+		Worlds.Add(IpvMulti2NetConvergenceTest::FindServerWorld());
+		for (UWorld* World : Worlds)
+		{
+			if (UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr)
+			{
+				NetDriver->SetPacketSimulationSettings(Settings);
+			}
+		}
+#endif
+	}
+
+	void Finish()
+	{
+		ApplyProfile(IpvMulti2NetConvergenceTest::CleanProfile);
+
+		FString Csv = TEXT("Profile,Step,Samples,Timeouts,P50Ms,P90Ms,P99Ms,MaxMs\n");
+		for (int32 StepIndex = 0; StepIndex < (int32)EStep::Num; ++StepIndex)
+		{
+			TArray<double>& Samples = LatencyMs[StepIndex];
+			Samples.Sort();
+
+			const double P50 = IpvMulti2NetConvergenceTest::Percentile(Samples, 0.5);
+			const double P90 = IpvMulti2NetConvergenceTest::Percentile(Samples, 0.9);
+			const double P99 = IpvMulti2NetConvergenceTest::Percentile(Samples, 0.99);
+			const double Max = IpvMulti2NetConvergenceTest::Percentile(Samples, 1.0);
+			const TCHAR* StepName = GetStepName((EStep)StepIndex);
+
+			Test->AddInfo(FString::Printf(TEXT("profile=%s step=%s samples=%d timeouts=%d p50=%.1fms p90=%.1fms p99=%.1fms max=%.1fms"),
+				*Profile, StepName, Samples.Num(), Timeouts[StepIndex], P50, P90, P99, Max));
+			Csv += FString::Printf(TEXT("%s,%s,%d,%d,%.1f,%.1f,%.1f,%.1f\n"),
+				*Profile, StepName, Samples.Num(), Timeouts[StepIndex], P50, P90, P99, Max);
+		}
+
+		const FString CsvPath = FPaths::ProjectSavedDir() / TEXT("Profiling") / FString::Printf(TEXT("IpvNetConvergence_%s.csv"), *Profile);
+		FFileHelper::SaveStringToFile(Csv, *CsvPath);
+		Test->AddInfo(FString::Printf(TEXT("Convergence latencies written to %s"), *CsvPath));
+	}
+
+	FAutomationTestBase* Test;
+	FString Profile;
+	int32 Iterations;
+
+	EPhase Phase = EPhase::WaitForPlayers;
+	double StartTime = 0.0;
+	double SettleUntilTime = 0.0;
+
+	/** Server-side PlayerIds of the characters controlled by remote clients. */
+	TArray<int32> TargetPlayerIds;
+
+	int32 Iteration = 0;
+	EStep Step = EStep::Fire;
+	int32 TargetPlayerId = INDEX_NONE;
+	int32 ExpectedAmmo = 0;
+	double StepStartTime = 0.0;
+
+	TArray<double> LatencyMs[(int32)EStep::Num];
+	int32 Timeouts[(int32)EStep::Num] = {};
+};
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FIpvMulti2NetConvergenceTest, "IpvMulti2.Network.Convergence", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+void FIpvMulti2NetConvergenceTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	// One test per project packet simulation profile (PacketSimulationProfile.Ipv*), plus a run without emulation
+	TArray<FString> Profiles = { IpvMulti2NetConvergenceTest::CleanProfile };
+
+	TArray<FString> SectionNames;
+	GConfig->GetSectionNames(GEngineIni, SectionNames);
+	const FString ProjectProfilePrefix = FString(IpvMulti2NetConvergenceTest::ProfileSectionPrefix) + TEXT("Ipv");
+	for (const FString& SectionName : SectionNames)
+	{
+		if (SectionName.StartsWith(ProjectProfilePrefix))
+		{
+			Profiles.Add(SectionName.RightChop(FCString::Strlen(IpvMulti2NetConvergenceTest::ProfileSectionPrefix)));
+		}
+	}
+
+	for (const FString& Profile : Profiles)
+	{
+		OutBeautifiedNames.Add(Profile);
+		OutTestCommands.Add(Profile);
+	}
+}
+
+bool FIpvMulti2NetConvergenceTest::RunTest(const FString& Parameters)
+{
+	const FString& Profile = Parameters;
+
+	// Validate before starting PIE so a bad profile name fails immediately
+	FPacketSimulationSettings Settings;
+	if (!IpvMulti2NetConvergenceTest::LoadProfile(Profile, Settings))
+	{
+		AddError(FString::Printf(TEXT("No usable [%s%s] section in DefaultEngine.ini (or packet simulation is compiled out)"),
+			IpvMulti2NetConvergenceTest::ProfileSectionPrefix, *Profile));
+		return false;
+	}
+
+	AutomationOpenMap(IpvMulti2NetConvergenceTest::MapName);
+
+	ADD_LATENT_AUTOMATION_COMMAND(FIpvMulti2StartMultiplayerPIECommand());
+	ADD_LATENT_AUTOMATION_COMMAND(FIpvMulti2NetConvergenceCommand(this, Profile));
+	ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS && WITH_EDITOR